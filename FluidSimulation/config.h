@@ -69,6 +69,36 @@ void adjustSprings_Ver3(void);
 /* Modify positions according to double density relaxation */
 void doubleDensityRelaxation_Ver3(void);
 
+/* Interaction radius h between two particles of possibly different sizes */
+double pairInteractRadius(Particle*, Particle*);
+
+/* Ratio of the full resolution h to the pair's h */
+double kernelScale(Particle*, Particle*);
+
+/* Kernel weight of a neighbour, scaled by its mass and size */
+double neighbourWeight(Particle*, Particle*);
+
+/* Give a particle the given mass and the radii that go with it */
+void setParticleMass(Particle*, double);
+
+/* Merge calm particles deep inside the fluid, split those near the surface or moving fast */
+void adaptResolution(void);
+
+/* Measure every particle's neighbour offset, neighbour mass and distance to the free surface */
+void measureSurface(void);
+
+/* Whether a particle lies on the free surface or in a splash */
+int isSurfaceParticle(Particle*);
+
+/* Merge the second particle into the first and free its slot */
+void mergeParticles(Particle*, Particle*);
+
+/* Split a particle into two halves, the second one in a free slot */
+void splitParticle(Particle*);
+
+/* Remove every spring attached to the given particle */
+void clearSprings(int);
+
 /* Modify positions according to collisions */
 void resolveCollisions_Ver4(void);
 void resolveCollisions(void);
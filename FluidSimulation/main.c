@@ -60,6 +60,10 @@ void initParticleList() {
     for (int i = 0; i < LIST_SIZE; i++) {
         // Index
         particleList[i].index = i;
+        particleList[i].active = 1;
+        
+        // Every particle starts at full resolution
+        setParticleMass(&particleList[i], MIN_PARTICLE_MASS);
         
         // Position
         particleList[i].pdctPosition.x = currentX;
@@ -114,6 +118,9 @@ void simulation() {
     // Use previous position to compute next velocity
     computeNextVelocity();
     
+    // Merge and split particles
+    adaptResolution();
+    
     // Extra credit
     extra();
     
@@ -127,6 +134,8 @@ void simulation() {
 
 void applyGravity() {
     for (int i = 0; i < LIST_SIZE; i++) {
+        if (!particleList[i].active)
+            continue;
         applyGravityOnOneParticle(&particleList[i]);
     }
 }
@@ -143,6 +152,8 @@ void applyGravityOnOneParticle(Particle* particle) {
 void positionSaveAndAdvance() {
     for (int i = 0; i < LIST_SIZE; i++) {
         Particle* p = &particleList[i];
+        if (!p->active)
+            continue;
         
         // Save previous position
         (p->prevPosition).x = (p->pdctPosition).x;
@@ -156,46 +167,83 @@ void positionSaveAndAdvance() {
     }
 }
 
+/******************
+ *   Kernel Sizes
+ ******************/
+
+double pairInteractRadius(Particle* p, Particle* neighbour) {
+    // Symmetric, so that pairwise impulses stay equal and opposite
+    return (p->interactRadius + neighbour->interactRadius) * 0.5;
+}
+
+double kernelScale(Particle* p, Particle* neighbour) {
+    return INTERACT_RADIUS / pairInteractRadius(p, neighbour);
+}
+
+double neighbourWeight(Particle* p, Particle* neighbour) {
+    // A merged particle stands for `mass` full resolution particles spread over a larger kernel
+    const double scale = kernelScale(p, neighbour);
+    return neighbour->mass * scale * scale * scale;
+}
+
+void setParticleMass(Particle* p, double mass) {
+    // Volume grows linearly with mass
+    const double scale = cbrt(mass / MIN_PARTICLE_MASS);
+    p->mass = mass;
+    p->radius = PARTICLE_RADIUS * scale;
+    p->interactRadius = INTERACT_RADIUS * scale;
+}
+
 /******************
  * Apply Viscosity
  ******************/
 void applyViscosity_Ver3 () {
     for (int i = 0; i < LIST_SIZE; i++) {
         Particle* p = &particleList[i];
+        if (!p->active)
+            continue;
         for (int j = i + 1; j < LIST_SIZE; j++) {
             Particle* neighbour = &particleList[j];
+            if (!neighbour->active)
+                continue;
             
             const double deltaX = (neighbour->pdctPosition).x - (p->pdctPosition).x;
             const double deltaY = (neighbour->pdctPosition).y - (p->pdctPosition).y;
             const double deltaZ = (neighbour->pdctPosition).z - (p->pdctPosition).z;
             const double distance = sqrt(deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ);
+            const double h = pairInteractRadius(p, neighbour);
             
-            if (distance > INTERACT_RADIUS) {
+            if (distance > h) {
                 continue;
             }
             
             // Calculate q
-            const double q = distance / INTERACT_RADIUS;
+            const double q = distance / h;
             if (q < 1) {
                 // inward radical velocity
                 const double u = (p->velocity.x - neighbour->velocity.x) * deltaX / distance +
                                     (p->velocity.y - neighbour->velocity.y) * deltaY / distance +
                                     (p->velocity.z - neighbour->velocity.z) * deltaZ / distance;
                 if(u > 0) {
-                    // Linear and quadratic impulses
-                    const double factor = TIME_INTERVAL * (1 - q) * (VISCOSITY_SIGMA * u + VISCOSITY_BETA * u * u);
+                    // Linear and quadratic impulses, scaled so a larger kernel sees the same velocity Laplacian
+                    const double scale = kernelScale(p, neighbour);
+                    const double factor = scale * scale * TIME_INTERVAL * (1 - q) * (VISCOSITY_SIGMA * u + VISCOSITY_BETA * u * u);
                     double I[3] = {0, 0, 0};
                     I[0] = factor * deltaX / distance;
                     I[1] = factor * deltaY / distance;
                     I[2] = factor * deltaZ / distance;
                     
-                    p->velocity.x = p->velocity.x - I[0] * 0.5;
-                    p->velocity.y = p->velocity.y - I[1] * 0.5;
-                    p->velocity.z = p->velocity.z - I[2] * 0.5;
+                    // Share the impulse by mass, so the heavier particle changes less
+                    const double pShare = neighbour->mass / (p->mass + neighbour->mass);
+                    const double nShare = p->mass / (p->mass + neighbour->mass);
+                    
+                    p->velocity.x = p->velocity.x - I[0] * pShare;
+                    p->velocity.y = p->velocity.y - I[1] * pShare;
+                    p->velocity.z = p->velocity.z - I[2] * pShare;
                     
-                    neighbour->velocity.x = neighbour->velocity.x + I[0] * 0.5;
-                    neighbour->velocity.y = neighbour->velocity.y + I[1] * 0.5;
-                    neighbour->velocity.z = neighbour->velocity.z + I[2] * 0.5;
+                    neighbour->velocity.x = neighbour->velocity.x + I[0] * nShare;
+                    neighbour->velocity.y = neighbour->velocity.y + I[1] * nShare;
+                    neighbour->velocity.z = neighbour->velocity.z + I[2] * nShare;
                 }
             }
         }
@@ -208,32 +256,40 @@ void applyViscosity_Ver3 () {
 void adjustSprings_Ver3() {
     for (int i = 0; i < LIST_SIZE; i++) {
         Particle* p = &particleList[i];
+        if (!p->active)
+            continue;
         for (int j = i + 1; j < LIST_SIZE; j++) {
             Particle* neighbour = &particleList[j];
+            if (!neighbour->active)
+                continue;
             
             const double deltaX = (neighbour->pdctPosition).x - (p->pdctPosition).x;
             const double deltaY = (neighbour->pdctPosition).y - (p->pdctPosition).y;
             const double deltaZ = (neighbour->pdctPosition).z - (p->pdctPosition).z;
             const double distance = sqrt(deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ);
+            const double h = pairInteractRadius(p, neighbour);
             
-            if (distance > INTERACT_RADIUS) {
+            if (distance > h) {
                 continue;
             }
             
+            // Rest length scales with the size of the pair
+            const double restLength = REST_LENGTH * h / INTERACT_RADIUS;
+            
             // Calculate q
-            const double q = distance / INTERACT_RADIUS;
+            const double q = distance / h;
             if (q < 1) {
                 // If there is no spring ij, add spring ij with rest length h
                 if (springList[i][j] != -1) {
-                    springList[i][j] = INTERACT_RADIUS;
+                    springList[i][j] = h;
                 }
                 // Tolerable deformation = yield ratio * rest length
                 double d = YIELD_RATIO * springList[i][j];
                 
-                if(distance > REST_LENGTH + d) { // Stretch
-                    springList[i][j] = springList[i][j] + TIME_INTERVAL * PLASTICITY * (distance - REST_LENGTH - d);
-                } else if (distance < REST_LENGTH - d) { // Compress
-                    springList[i][j] = springList[i][j] - TIME_INTERVAL * PLASTICITY * (REST_LENGTH - d - distance);
+                if(distance > restLength + d) { // Stretch
+                    springList[i][j] = springList[i][j] + TIME_INTERVAL * PLASTICITY * (distance - restLength - d);
+                } else if (distance < restLength - d) { // Compress
+                    springList[i][j] = springList[i][j] - TIME_INTERVAL * PLASTICITY * (restLength - d - distance);
                 }
             }
         }
@@ -242,7 +298,7 @@ void adjustSprings_Ver3() {
     // Remove spring
     for(int i = 0; i < LIST_SIZE; i++) {
         for (int j = i + 1; j < LIST_SIZE; j++) {
-            if(springList[i][j] > INTERACT_RADIUS) {
+            if(springList[i][j] > pairInteractRadius(&particleList[i], &particleList[j])) {
                 springList[i][j] = -1.0;
             }
         }
@@ -256,27 +312,30 @@ void adjustSprings_Ver3() {
                 const double deltaY = (&particleList[j])->pdctPosition.y - (&particleList[i])->pdctPosition.y;
                 const double deltaZ = (&particleList[j])->pdctPosition.z - (&particleList[i])->pdctPosition.z;
                 const double distance = sqrt(deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ);
+                const double h = pairInteractRadius(&particleList[i], &particleList[j]);
                 
-                if (distance > INTERACT_RADIUS) {
+                if (distance > h) {
                     continue;
                 }
                 
                 const double Lij = springList[i][j];
                 
-                const double factor = TIME_INTERVAL * TIME_INTERVAL * STIFF_SPRING * (1 - Lij / INTERACT_RADIUS) * (Lij - distance);
+                const double factor = TIME_INTERVAL * TIME_INTERVAL * STIFF_SPRING * (1 - Lij / h) * (Lij - distance);
+                const double iShare = particleList[j].mass / (particleList[i].mass + particleList[j].mass);
+                const double jShare = particleList[i].mass / (particleList[i].mass + particleList[j].mass);
                 
                 double D[3] = {0, 0, 0};
                 D[0] = factor * deltaX / distance;
                 D[1] = factor * deltaY / distance;
                 D[2] = factor * deltaZ / distance;
                 
-                (&particleList[i])->pdctPosition.x = (&particleList[i])->pdctPosition.x - D[0] * 0.5;
-                (&particleList[i])->pdctPosition.y = (&particleList[i])->pdctPosition.y - D[1] * 0.5;
-                (&particleList[i])->pdctPosition.z = (&particleList[i])->pdctPosition.z - D[2] * 0.5;
+                (&particleList[i])->pdctPosition.x = (&particleList[i])->pdctPosition.x - D[0] * iShare;
+                (&particleList[i])->pdctPosition.y = (&particleList[i])->pdctPosition.y - D[1] * iShare;
+                (&particleList[i])->pdctPosition.z = (&particleList[i])->pdctPosition.z - D[2] * iShare;
                 
-                (&particleList[j])->pdctPosition.x = (&particleList[j])->pdctPosition.x + D[0] * 0.5;
-                (&particleList[j])->pdctPosition.y = (&particleList[j])->pdctPosition.y + D[1] * 0.5;
-                (&particleList[j])->pdctPosition.z = (&particleList[j])->pdctPosition.z + D[2] * 0.5;
+                (&particleList[j])->pdctPosition.x = (&particleList[j])->pdctPosition.x + D[0] * jShare;
+                (&particleList[j])->pdctPosition.y = (&particleList[j])->pdctPosition.y + D[1] * jShare;
+                (&particleList[j])->pdctPosition.z = (&particleList[j])->pdctPosition.z + D[2] * jShare;
             }
         }
     }
@@ -288,6 +347,8 @@ void adjustSprings_Ver3() {
 void doubleDensityRelaxation_Ver3() {
     for (int i = 0; i < LIST_SIZE; i++) {
         Particle* p = &particleList[i];
+        if (!p->active)
+            continue;
         
         // Reset densities
         p->density = 0;
@@ -298,18 +359,22 @@ void doubleDensityRelaxation_Ver3() {
             if(i == j)
                 continue;
             Particle* neighbour = &particleList[j];
+            if(!neighbour->active)
+                continue;
             const double deltaX = (neighbour->pdctPosition).x - (p->pdctPosition).x;
             const double deltaY = (neighbour->pdctPosition).y - (p->pdctPosition).y;
             const double deltaZ = (neighbour->pdctPosition).z - (p->pdctPosition).z;
             const double distance = sqrt(deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ);
+            const double h = pairInteractRadius(p, neighbour);
             
-            if(distance > INTERACT_RADIUS)
+            if(distance > h)
                 continue;
             
-            const double q = distance / INTERACT_RADIUS;
+            const double q = distance / h;
             if(q < 1) {
-                p->density = p->density + (1 - q) * (1 - q);
-                p->nearDensity = p->nearDensity + (1 - q) * (1 - q) * (1 - q);
+                const double w = neighbourWeight(p, neighbour);
+                p->density = p->density + w * (1 - q) * (1 - q);
+                p->nearDensity = p->nearDensity + w * (1 - q) * (1 - q) * (1 - q);
             }
         }
         
@@ -321,27 +386,34 @@ void doubleDensityRelaxation_Ver3() {
             if(i == j)
                 continue;
             Particle* neighbour = &particleList[j];
+            if(!neighbour->active)
+                continue;
             const double deltaX = (neighbour->pdctPosition).x - (p->pdctPosition).x;
             const double deltaY = (neighbour->pdctPosition).y - (p->pdctPosition).y;
             const double deltaZ = (neighbour->pdctPosition).z - (p->pdctPosition).z;
             const double distance = sqrt(deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ);
+            const double h = pairInteractRadius(p, neighbour);
             
-            if(distance > INTERACT_RADIUS)
+            if(distance > h)
                 continue;
             
-            const double q = distance / INTERACT_RADIUS;
+            const double q = distance / h;
             if(q < 1) {
-                const double factor = TIME_INTERVAL * TIME_INTERVAL * (P * (1 - q) + P_near * (1 - q) * (1 - q));
+                // Scaled so a larger kernel answers the same pressure gradient with the same displacement
+                const double factor = kernelScale(p, neighbour) * TIME_INTERVAL * TIME_INTERVAL * (P * (1 - q) + P_near * (1 - q) * (1 - q));
                 double D[3] = {factor, factor, factor};
                 D[0] = D[0] * deltaX / distance;
                 D[1] = D[1] * deltaY / distance;
                 D[2] = D[2] * deltaZ / distance;
-                neighbour->pdctPosition.x = neighbour->pdctPosition.x + D[0] / 2;
-                neighbour->pdctPosition.y = neighbour->pdctPosition.y + D[1] / 2;
-                neighbour->pdctPosition.z = neighbour->pdctPosition.z + D[2] / 2;
-                dx[0] = dx[0] - D[0] / 2;
-                dx[1] = dx[1] - D[1] / 2;
-                dx[2] = dx[2] - D[2] / 2;
+                // Lighter particle of the pair is displaced more
+                const double pShare = neighbour->mass / (p->mass + neighbour->mass);
+                const double nShare = p->mass / (p->mass + neighbour->mass);
+                neighbour->pdctPosition.x = neighbour->pdctPosition.x + D[0] * nShare;
+                neighbour->pdctPosition.y = neighbour->pdctPosition.y + D[1] * nShare;
+                neighbour->pdctPosition.z = neighbour->pdctPosition.z + D[2] * nShare;
+                dx[0] = dx[0] - D[0] * pShare;
+                dx[1] = dx[1] - D[1] * pShare;
+                dx[2] = dx[2] - D[2] * pShare;
             }
         }
         p->pdctPosition.x = p->pdctPosition.x + dx[0];
@@ -351,7 +423,7 @@ void doubleDensityRelaxation_Ver3() {
 }
 
 
-int count = 0;
+double count = 0;    // Mass in contact with the floor
 int onair = 1;
 /*******************
  *     Collision
@@ -360,28 +432,32 @@ void resolveCollisions_Ver4() {
     count = 0;
     for (int i = 0; i < LIST_SIZE; i++) {
         Particle* p = &particleList[i];
+        if (!p->active)
+            continue;
+        // A merged particle keeps its centre where its outermost full resolution particles would be
+        const double inset = p->radius - PARTICLE_RADIUS;
         /* Out of X bound */
-        if ((p->pdctPosition).x < TANK_xMin) {
+        if ((p->pdctPosition).x < TANK_xMin + inset) {
             (p->velocity).x *= -0.9;
-            (p->pdctPosition).x = TANK_xMin + (p->velocity).x * TIME_INTERVAL;
-        } else if ((p->pdctPosition).x > TANK_xMax) {
+            (p->pdctPosition).x = TANK_xMin + inset + (p->velocity).x * TIME_INTERVAL;
+        } else if ((p->pdctPosition).x > TANK_xMax - inset) {
             (p->velocity).x *= -0.9;
-            (p->pdctPosition).x = TANK_xMax - (p->velocity).x * TIME_INTERVAL;
+            (p->pdctPosition).x = TANK_xMax - inset - (p->velocity).x * TIME_INTERVAL;
         }
         /* Out of Y bound */
-        if ((p->pdctPosition).y <= TANK_yMin) {
+        if ((p->pdctPosition).y <= TANK_yMin + inset) {
             (p->velocity).y *= -0.9;
-            (p->pdctPosition).y = TANK_yMin;// + (p->velocity).y * TIME_INTERVAL;
-            count++;
+            (p->pdctPosition).y = TANK_yMin + inset;// + (p->velocity).y * TIME_INTERVAL;
+            count += p->mass;
             onair = 0;
-        } else if ((p->pdctPosition).y > TANK_yMax) {
+        } else if ((p->pdctPosition).y > TANK_yMax - inset) {
             (p->velocity).y *= -0.9;
-            (p->pdctPosition).y = TANK_yMax - (p->velocity).y * TIME_INTERVAL;
+            (p->pdctPosition).y = TANK_yMax - inset - (p->velocity).y * TIME_INTERVAL;
         }
         /* Out of Z bound */
-        if ((p->pdctPosition).z < TANK_zMin) {
+        if ((p->pdctPosition).z < TANK_zMin + inset) {
             (p->velocity).z *= -0.9;
-            (p->pdctPosition).z = TANK_zMin + (p->velocity).z * TIME_INTERVAL;
+            (p->pdctPosition).z = TANK_zMin + inset + (p->velocity).z * TIME_INTERVAL;
         }/*else if ((p->pdctPosition).z > TANK_zMax) {
             //(p->velocity).z *= -1;
         }*/
@@ -401,11 +477,13 @@ void extra() {
             energyLoss++;
         justIncr = 1;
     }
-    if (count > LIST_SIZE * 0.1 && count < LIST_SIZE * 0.8 && onair == 0 && added == 0) {
+    if (count > LIST_SIZE * MIN_PARTICLE_MASS * 0.1 && count < LIST_SIZE * MIN_PARTICLE_MASS * 0.8 && onair == 0 && added == 0) {
         justIncr = 0;
         const double dv = sqrt(GRAVITY * input_yMin * 5 * 2 * pow(energyLossPercent, energyLoss));
         for (int i = 0; i < LIST_SIZE; i++) {
             Particle* p = &particleList[i];
+            if(!p->active)
+                continue;
             if((p->velocity).y < 0 && (p->pdctPosition).y <= TANK_yMin)
                 (p->velocity).y = dv;
             else if ((p->velocity).y < 0) {
@@ -423,6 +501,8 @@ void extra() {
 void computeNextVelocity() {
     for (int i = 0; i < LIST_SIZE; i++) {
         Particle* p = &particleList[i];
+        if (!p->active)
+            continue;
         
         // Use previous position to compute next velocity
         (p->velocity).x = ((p->pdctPosition).x - (p->prevPosition).x) / TIME_INTERVAL;
@@ -442,6 +522,235 @@ void calculateVelocity(Particle* p) {
 }
 
 
+/*********************
+ * Adaptive Resolution
+ *********************/
+
+void adaptResolution() {
+    measureSurface();
+    
+    // Decide every split before changing anything, so each particle splits at most once per step
+    int splitList[LIST_SIZE] = {0};
+    for (int i = 0; i < LIST_SIZE; i++) {
+        Particle* p = &particleList[i];
+        if (!p->active)
+            continue;
+        
+        const double speed = sqrt(p->velocity.x * p->velocity.x +
+                                  p->velocity.y * p->velocity.y +
+                                  p->velocity.z * p->velocity.z);
+        p->calmSteps = speed > MERGE_SPEED ? 0 : p->calmSteps + 1;
+        
+        // Near the free surface or splashing: restore detail
+        if (isSurfaceParticle(p) || speed > SPLIT_SPEED || p->surfaceDistance - p->radius < SPLIT_CLEARANCE)
+            splitList[i] = 1;
+    }
+    
+    for (int i = 0; i < LIST_SIZE; i++) {
+        Particle* p = &particleList[i];
+        if (!p->active || splitList[i])
+            continue;
+        
+        // Deep inside calm, settled fluid: merge with the closest calm neighbour
+        if (p->calmSteps < MERGE_CALM_STEPS)
+            continue;
+        const double mergedRadius = PARTICLE_RADIUS * cbrt(2 * p->mass / MIN_PARTICLE_MASS);
+        
+        Particle* closest = NULL;
+        double closestDistance = 0;
+        for (int j = i + 1; j < LIST_SIZE; j++) {
+            Particle* neighbour = &particleList[j];
+            if (!neighbour->active || splitList[j])
+                continue;
+            if (neighbour->calmSteps < MERGE_CALM_STEPS)
+                continue;
+            
+            // Equal masses keep every mass a power of two, so splitting always returns to full resolution
+            if (neighbour->mass != p->mass || p->mass + neighbour->mass > MAX_PARTICLE_MASS)
+                continue;
+            
+            const double dvX = neighbour->velocity.x - p->velocity.x;
+            const double dvY = neighbour->velocity.y - p->velocity.y;
+            const double dvZ = neighbour->velocity.z - p->velocity.z;
+            if (sqrt(dvX * dvX + dvY * dvY + dvZ * dvZ) > MERGE_SPEED)
+                continue;
+            
+            const double deltaX = (neighbour->pdctPosition).x - (p->pdctPosition).x;
+            const double deltaY = (neighbour->pdctPosition).y - (p->pdctPosition).y;
+            const double deltaZ = (neighbour->pdctPosition).z - (p->pdctPosition).z;
+            const double distance = sqrt(deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ);
+            
+            // Only particles close to touching are merged
+            if (distance > MERGE_DISTANCE * (p->radius + neighbour->radius))
+                continue;
+            
+            // The merged particle lies within `distance` of both, and must still be clear of the surface
+            if (fmin(p->surfaceDistance, neighbour->surfaceDistance) - distance - mergedRadius < MERGE_CLEARANCE)
+                continue;
+            if (closest == NULL || distance < closestDistance) {
+                closest = neighbour;
+                closestDistance = distance;
+            }
+        }
+        if (closest != NULL)
+            mergeParticles(p, closest);
+    }
+    
+    // Children land in free slots, which are never in splitList
+    for (int i = 0; i < LIST_SIZE; i++) {
+        if (splitList[i])
+            splitParticle(&particleList[i]);
+    }
+}
+
+void measureSurface() {
+    for (int i = 0; i < LIST_SIZE; i++) {
+        Particle* p = &particleList[i];
+        if (!p->active)
+            continue;
+        
+        double mass = 0;
+        double offset[3] = {0, 0, 0};
+        for (int j = 0; j < LIST_SIZE; j++) {
+            Particle* neighbour = &particleList[j];
+            if (i == j || !neighbour->active)
+                continue;
+            const double deltaX = (neighbour->pdctPosition).x - (p->pdctPosition).x;
+            const double deltaY = (neighbour->pdctPosition).y - (p->pdctPosition).y;
+            const double deltaZ = (neighbour->pdctPosition).z - (p->pdctPosition).z;
+            const double distance = sqrt(deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ);
+            
+            // Count a merged neighbour as soon as its edge is in range
+            if (distance > SURFACE_RADIUS + neighbour->radius)
+                continue;
+            mass += neighbour->mass;
+            offset[0] = offset[0] - neighbour->mass * deltaX;
+            offset[1] = offset[1] - neighbour->mass * deltaY;
+            offset[2] = offset[2] - neighbour->mass * deltaZ;
+        }
+        
+        p->neighbourMass = mass;
+        if (mass == 0) {
+            p->neighbourOffset = 1;
+            continue;
+        }
+        
+        // Neighbours missing towards a tank wall do not make a free surface
+        if (offset[0] < 0 && (p->pdctPosition).x - TANK_xMin < SURFACE_RADIUS)
+            offset[0] = 0;
+        if (offset[0] > 0 && TANK_xMax - (p->pdctPosition).x < SURFACE_RADIUS)
+            offset[0] = 0;
+        if (offset[1] < 0 && (p->pdctPosition).y - TANK_yMin < SURFACE_RADIUS)
+            offset[1] = 0;
+        if (offset[2] < 0 && (p->pdctPosition).z - TANK_zMin < SURFACE_RADIUS)
+            offset[2] = 0;
+        
+        // 3/8 on a flat surface, 0 deep inside
+        p->neighbourOffset = sqrt(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]) / (mass * SURFACE_RADIUS);
+    }
+    
+    for (int i = 0; i < LIST_SIZE; i++) {
+        Particle* p = &particleList[i];
+        if (!p->active)
+            continue;
+        
+        p->surfaceDistance = isSurfaceParticle(p) ? 0 : TANK_yMax;
+        for (int j = 0; j < LIST_SIZE; j++) {
+            Particle* neighbour = &particleList[j];
+            if (i == j || !neighbour->active || !isSurfaceParticle(neighbour))
+                continue;
+            const double deltaX = (neighbour->pdctPosition).x - (p->pdctPosition).x;
+            const double deltaY = (neighbour->pdctPosition).y - (p->pdctPosition).y;
+            const double deltaZ = (neighbour->pdctPosition).z - (p->pdctPosition).z;
+            const double distance = sqrt(deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ);
+            if (distance < p->surfaceDistance)
+                p->surfaceDistance = distance;
+        }
+    }
+}
+
+int isSurfaceParticle(Particle* p) {
+    return p->neighbourOffset > SURFACE_OFFSET || p->neighbourMass < SPLASH_MASS;
+}
+
+void mergeParticles(Particle* p, Particle* neighbour) {
+    const double mass = p->mass + neighbour->mass;
+    const double pShare = p->mass / mass;
+    const double nShare = neighbour->mass / mass;
+    
+    // Conserve momentum and centre of mass
+    p->pdctPosition.x = p->pdctPosition.x * pShare + neighbour->pdctPosition.x * nShare;
+    p->pdctPosition.y = p->pdctPosition.y * pShare + neighbour->pdctPosition.y * nShare;
+    p->pdctPosition.z = p->pdctPosition.z * pShare + neighbour->pdctPosition.z * nShare;
+    
+    p->prevPosition.x = p->prevPosition.x * pShare + neighbour->prevPosition.x * nShare;
+    p->prevPosition.y = p->prevPosition.y * pShare + neighbour->prevPosition.y * nShare;
+    p->prevPosition.z = p->prevPosition.z * pShare + neighbour->prevPosition.z * nShare;
+    
+    p->velocity.x = p->velocity.x * pShare + neighbour->velocity.x * nShare;
+    p->velocity.y = p->velocity.y * pShare + neighbour->velocity.y * nShare;
+    p->velocity.z = p->velocity.z * pShare + neighbour->velocity.z * nShare;
+    
+    setParticleMass(p, mass);
+    
+    // Free the neighbour's slot for a later split
+    neighbour->active = 0;
+    
+    // Spring rest lengths no longer match the new sizes
+    clearSprings(p->index);
+    clearSprings(neighbour->index);
+}
+
+void splitParticle(Particle* p) {
+    if (p->mass < 2 * MIN_PARTICLE_MASS)
+        return;
+    
+    // Reuse a slot freed by an earlier merge
+    Particle* child = NULL;
+    for (int i = 0; i < LIST_SIZE; i++) {
+        if (!particleList[i].active) {
+            child = &particleList[i];
+            break;
+        }
+    }
+    if (child == NULL)
+        return;
+    
+    const int index = child->index;
+    *child = *p;
+    child->index = index;
+    
+    setParticleMass(p, p->mass / 2);
+    setParticleMass(child, p->mass);
+    p->calmSteps = 0;
+    child->calmSteps = 0;
+    
+    // Place the halves side by side along x, where the tank is widest, keeping both inside it
+    const double reach = 2 * p->radius - PARTICLE_RADIUS;
+    double centreX = p->pdctPosition.x;
+    if (centreX - reach < TANK_xMin) {
+        centreX = TANK_xMin + reach;
+    } else if (centreX + reach > TANK_xMax) {
+        centreX = TANK_xMax - reach;
+    }
+    const double shift = centreX - p->pdctPosition.x;
+    
+    p->pdctPosition.x += shift - p->radius;
+    p->prevPosition.x += shift - p->radius;
+    child->pdctPosition.x += shift + child->radius;
+    child->prevPosition.x += shift + child->radius;
+    
+    clearSprings(p->index);
+    clearSprings(child->index);
+}
+
+void clearSprings(int index) {
+    for (int i = 0; i < LIST_SIZE; i++) {
+        springList[i][index] = -1;
+        springList[index][i] = -1;
+    }
+}
+
 /*******************
  *      Render
  *******************/
@@ -482,8 +791,10 @@ void render() {
     // Render
     for (int i = 0; i < LIST_SIZE; i++) {
         Particle* p = &particleListTemp[i];
+        if (!p->active)
+            continue;
         glTranslatef((p->pdctPosition).x, (p->pdctPosition).y, (p->pdctPosition).z);
-        glutSolidSphere(PARTICLE_RADIUS, SPHERE_SLICES, SPHERE_STACKS);
+        glutSolidSphere(p->radius, SPHERE_SLICES, SPHERE_STACKS);
         glTranslatef(-(p->pdctPosition).x, -(p->pdctPosition).y, -(p->pdctPosition).z);
     }
     glFlush();
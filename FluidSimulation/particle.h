@@ -34,6 +34,23 @@ const double TIME_INTERVAL = 1/30.0;  // Time interval
 
 const double REST_LENGTH = PARTICLE_RADIUS;     // Spring rest length
 
+// Adaptive resolution
+const double MIN_PARTICLE_MASS = 1.0;   // Mass of a particle at full resolution
+const double MAX_PARTICLE_MASS = 8.0;   // Largest mass a merged particle may reach, a power of two
+
+// Surface measure, taken over a fixed radius so it does not change as particles merge
+const double SURFACE_RADIUS = INTERACT_RADIUS;  // Radius searched for neighbours
+const double SURFACE_OFFSET = 0.3;  // Centre of neighbours this far away (in SURFACE_RADIUS) marks the free surface
+const double SPLASH_MASS = 8.0;     // Less neighbour mass than this marks a splash
+
+const double MERGE_CLEARANCE = 4 * PARTICLE_RADIUS;    // A merged particle's edge must stay two full resolution layers from the free surface
+const double SPLIT_CLEARANCE = 0.5 * MERGE_CLEARANCE;   // Merged particles closer than this to the free surface are split
+const double MERGE_SPEED = 2.0;     // Only particles slower than this may merge
+const int MERGE_CALM_STEPS = 30;    // Steps a particle must stay slow before it may merge
+const double MERGE_DISTANCE = 1.5;  // Merge partners may be this many contact distances apart
+
+const double SPLIT_SPEED = 6.0;     // Particles faster than this are split
+
 // Structs
 
 /* Position of a particle */
@@ -53,6 +70,14 @@ typedef struct Particle {
     Velocity velocity;      // Velocity of the particle
     double density;         // Density
     double nearDensity;     // Near density
+    double mass;            // Mass, MIN_PARTICLE_MASS at full resolution
+    double radius;          // Radius of the particle, grows with mass
+    double interactRadius;  // Radius of interaction h, grows with mass
+    double neighbourOffset; // Distance from the centre of neighbours, in SURFACE_RADIUS, ignoring tank walls
+    double neighbourMass;   // Mass of neighbours within SURFACE_RADIUS
+    double surfaceDistance; // Distance to the closest particle on the free surface
+    int calmSteps;          // Steps since the particle was last faster than MERGE_SPEED
+    int active;             // 0 if the slot was freed by a merge
     int index;
 } Particle;
 